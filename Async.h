@@ -0,0 +1,175 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Reader.h"
+
+#pragma once
+
+// C++20 coroutine support is required; the header is empty otherwise.
+#if defined(__cpp_impl_coroutine) || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+
+#include <coroutine>
+#include <functional>
+#include <string>
+
+namespace XML
+{
+
+// Coroutine front end for a push-fed Reader.
+// Each awaitable mirrors the Reader call of the same name and yields its bool result.
+// When the Reader is starved, the awaiting coroutine suspends; it is resumed from
+// feed or finish as soon as the call can complete. The application's async stream
+// calls feed from its completion handler. Only one coroutine may await at a time.
+// Other Reader calls (getAttribute, getElementName, ...) never wait for input;
+// use them directly through reader().
+//
+//	XML::PushStream stream;
+//	XML::Reader reader;
+//	reader.open(&stream);
+//	XML::AsyncReader async(reader);
+//	...
+//	if ( co_await async.readStartElement("Root") )
+//	{
+//		while ( co_await async.readStartElement("Item") )
+//		{
+//			async.reader().getAttribute("id", strId);
+//			co_await async.readEndElement(false);
+//		}
+//		co_await async.readEndElement(false);
+//	}
+class AsyncReader
+{
+public:
+	class Awaitable
+	{
+		friend class AsyncReader;
+
+		AsyncReader &_owner;
+		std::function<bool()> _attempt;
+		bool _bResult;
+
+		// try the call; true if it completed (successfully or not).
+		bool attempt()
+		{
+			_bResult = _attempt();
+			return _bResult || !_owner._reader.starved();
+		}
+
+	public:
+		Awaitable(AsyncReader &owner, const std::function<bool()> &attempt) : 
+			_owner(owner), _attempt(attempt), _bResult(false) { };
+
+		bool await_ready() { return attempt(); }
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			_owner._pWaiting = this;
+			_owner._handle = handle;
+		}
+		bool await_resume() const { return _bResult; }
+	};
+
+private:
+	Reader &_reader;
+	// awaitable suspended for want of input, if any.
+	Awaitable *_pWaiting;
+	std::coroutine_handle<> _handle;
+
+	// retry the suspended call; resume its coroutine if it completed.
+	void resume()
+	{
+		if (_pWaiting != NULL && _pWaiting->attempt())
+		{
+			std::coroutine_handle<> handle = _handle;
+			_pWaiting = NULL;
+			_handle = std::coroutine_handle<>();
+			handle.resume();
+		}
+	}
+
+	// conclude elements until depth drops below iDepth.
+	// retrying after a partial skip resumes where it stopped.
+	bool endElements(bool bSkip, size_t iDepth)
+	{
+		if (iDepth == 0)
+			return false;
+		while (_reader.getDepth() >= iDepth)
+		{
+			if ( !_reader.readEndElement(bSkip) )
+				return false;
+		}
+		return true;
+	}
+
+public:
+	AsyncReader(Reader &reader) : _reader(reader), _pWaiting(NULL) { };
+
+	// underlying reader, for calls that never wait.
+	Reader &reader() { return _reader; }
+
+	// supply newly arrived octets; may resume the awaiting coroutine.
+	bool feed(const unsigned char *pOctets, size_t iOctets)
+	{
+		bool bOK = _reader.feed(pOctets, iOctets);
+		resume();
+		return bOK;
+	}
+	// no more octets will arrive; may resume the awaiting coroutine.
+	bool finish()
+	{
+		bool bOK = _reader.finish();
+		resume();
+		return bOK;
+	}
+
+	Awaitable isStartElement()
+	{
+		return Awaitable(*this, [this]() { return _reader.isStartElement(); });
+	}
+	Awaitable isStartElement(const char *strElement)
+	{
+		return Awaitable(*this, [this, strElement]() { return _reader.isStartElement(strElement); });
+	}
+	Awaitable readStartElement()
+	{
+		return Awaitable(*this, [this]() { return _reader.readStartElement(); });
+	}
+	Awaitable readStartElement(const char *strElement)
+	{
+		return Awaitable(*this, [this, strElement]() { return _reader.readStartElement(strElement); });
+	}
+	Awaitable isEndElement()
+	{
+		return Awaitable(*this, [this]() { return _reader.isEndElement(); });
+	}
+	Awaitable readEndElement(bool bSkip)
+	{
+		size_t iDepth = _reader.getDepth();
+		return Awaitable(*this, [this, bSkip, iDepth]() { return endElements(bSkip, iDepth); });
+	}
+	Awaitable readEndElement(bool bSkip, const char *strElement)
+	{
+		std::string strName;
+		if ( !_reader.getElementName(strName) || strName.compare(strElement) != 0 )
+			return Awaitable(*this, []() { return false; });
+		return readEndElement(bSkip);
+	}
+	Awaitable readPCData(std::string &strData)
+	{
+		return Awaitable(*this, [this, &strData]() { return _reader.readPCData(strData); });
+	}
+	Awaitable readPCData(std::wstring &strData)
+	{
+		return Awaitable(*this, [this, &strData]() { return _reader.readPCData(strData); });
+	}
+	Awaitable readCData(std::string &strData)
+	{
+		return Awaitable(*this, [this, &strData]() { return _reader.readCData(strData); });
+	}
+	Awaitable readCData(std::wstring &strData)
+	{
+		return Awaitable(*this, [this, &strData]() { return _reader.readCData(strData); });
+	}
+};
+
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,173 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Base64.h"
+
+namespace XML
+{
+
+static const char strAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// sextet values; Invalid marks characters outside the alphabet, Space marks whitespace.
+enum { Invalid = 0x40, Space = 0x41, Pad = 0x42 };
+
+// sextet value of each character; constant so decoders on any thread may share it.
+static const unsigned char sextets[256] = 
+{
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x41, 0x41, 0x40, 0x40, 0x41, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x41, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x3E, 0x40, 0x40, 0x40, 0x3F,
+	0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x40, 0x40, 0x40, 0x42, 0x40, 0x40,
+	0x40, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+	0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+	0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+	0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40
+};
+
+Base64::Base64() : _iBits(0), _iCount(0), _bPadded(false)
+{
+}
+
+// forget any partial quantum.
+void Base64::reset()
+{
+	_iBits = 0;
+	_iCount = 0;
+	_bPadded = false;
+}
+
+// encode octets, appending base64 text.
+void Base64::encode(const unsigned char *pOctets, size_t iOctets, std::string &strText)
+{
+	strText.reserve(strText.size() + (iOctets + _iCount) / 3 * 4 + 4);
+	const unsigned char *pEnd = pOctets + iOctets;
+	// top up a partial quantum left by the previous call.
+	while (_iCount > 0 && _iCount < 3 && pOctets != pEnd)
+	{
+		_iBits = (_iBits << 8) | *pOctets++;
+		if (++_iCount == 3)
+		{
+			strText += strAlphabet[(_iBits >> 18) & 0x3F];
+			strText += strAlphabet[(_iBits >> 12) & 0x3F];
+			strText += strAlphabet[(_iBits >> 6) & 0x3F];
+			strText += strAlphabet[_iBits & 0x3F];
+			_iBits = 0;
+			_iCount = 0;
+		}
+	}
+	// whole quanta.
+	while (pEnd - pOctets >= 3)
+	{
+		unsigned long iBits = (pOctets[0] << 16) | (pOctets[1] << 8) | pOctets[2];
+		char quad[4] = 
+		{
+			strAlphabet[(iBits >> 18) & 0x3F], strAlphabet[(iBits >> 12) & 0x3F],
+			strAlphabet[(iBits >> 6) & 0x3F], strAlphabet[iBits & 0x3F]
+		};
+		strText.append(quad, 4);
+		pOctets += 3;
+	}
+	// keep the remainder for next time.
+	while (pOctets != pEnd)
+	{
+		_iBits = (_iBits << 8) | *pOctets++;
+		_iCount++;
+	}
+}
+
+// conclude encoding: emit the final partial quantum with padding.
+void Base64::finish(std::string &strText)
+{
+	if (_iCount == 1)
+	{
+		strText += strAlphabet[(_iBits >> 2) & 0x3F];
+		strText += strAlphabet[(_iBits << 4) & 0x3F];
+		strText += "==";
+	}
+	else if (_iCount == 2)
+	{
+		strText += strAlphabet[(_iBits >> 10) & 0x3F];
+		strText += strAlphabet[(_iBits >> 4) & 0x3F];
+		strText += strAlphabet[(_iBits << 2) & 0x3F];
+		strText += '=';
+	}
+	reset();
+}
+
+// decode base64 text, appending octets. whitespace is ignored.
+// returns false on a character outside the base64 alphabet.
+bool Base64::decode(const char *pText, size_t iLen, std::string &strOctets)
+{
+	const unsigned char *table = sextets;
+	const unsigned char *pCursor = (const unsigned char *)pText;
+	const unsigned char *pEnd = pCursor + iLen;
+	strOctets.reserve(strOctets.size() + iLen / 4 * 3 + 3);
+	while (pCursor != pEnd)
+	{
+		// fast path: a whole quantum on a quantum boundary.
+		if (_iCount == 0 && !_bPadded && pEnd - pCursor >= 4)
+		{
+			unsigned char a = table[pCursor[0]], b = table[pCursor[1]];
+			unsigned char c = table[pCursor[2]], d = table[pCursor[3]];
+			if ( (a | b | c | d) < 0x40 )
+			{
+				unsigned long iBits = (a << 18) | (b << 12) | (c << 6) | d;
+				char triple[3] = { (char)(iBits >> 16), (char)(iBits >> 8), (char)iBits };
+				strOctets.append(triple, 3);
+				pCursor += 4;
+				continue;
+			}
+		}
+		unsigned char sextet = table[*pCursor++];
+		if (sextet == Space)
+			continue;
+		if (sextet == Invalid || (_bPadded && sextet != Pad))
+			return false;
+		if (sextet == Pad)
+		{
+			// padding completes a quantum of two or three sextets.
+			if (!_bPadded)
+			{
+				if (_iCount == 2)
+					strOctets += (char)(_iBits >> 4);
+				else if (_iCount == 3)
+				{
+					strOctets += (char)(_iBits >> 10);
+					strOctets += (char)(_iBits >> 2);
+				}
+				else
+					return false;
+			}
+			_bPadded = true;
+			_iBits = 0;
+			_iCount = 0;
+			continue;
+		}
+		_iBits = (_iBits << 6) | sextet;
+		if (++_iCount == 4)
+		{
+			char triple[3] = { (char)(_iBits >> 16), (char)(_iBits >> 8), (char)_iBits };
+			strOctets.append(triple, 3);
+			_iBits = 0;
+			_iCount = 0;
+		}
+	}
+	return true;
+}
+
+// conclude decoding: returns false if a partial quantum remains.
+bool Base64::finish()
+{
+	bool bOK = _iCount == 0;
+	reset();
+	return bOK;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,37 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Streaming base64 encoder / decoder (RFC 4648 alphabet).
+// The partial quantum is kept between calls so data may be supplied
+// in chunks of any size.
+class Base64
+{
+	// accumulated bits not yet emitted.
+	unsigned long _iBits;
+	// number of octets (encoding) or sextets (decoding) accumulated.
+	size_t _iCount;
+	// true once decoding has seen padding.
+	bool _bPadded;
+
+public:
+	Base64();
+	// forget any partial quantum.
+	void reset();
+	// encode octets, appending base64 text.
+	void encode(const unsigned char *pOctets, size_t iOctets, std::string &strText);
+	// conclude encoding: emit the final partial quantum with padding.
+	void finish(std::string &strText);
+	// decode base64 text, appending octets. whitespace is ignored.
+	// returns false on a character outside the base64 alphabet.
+	bool decode(const char *pText, size_t iLen, std::string &strOctets);
+	// conclude decoding: returns false if a partial quantum remains.
+	bool finish();
+};
+
+};
\ No newline at end of file
@@ -0,0 +1,48 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Fragment.h"
+
+namespace XML
+{
+
+Fragment::Fragment()
+{
+}
+
+// appends octets to the buffer.
+bool Fragment::Write(unsigned char *pOctets, size_t iOctets, size_t &iWrote)
+{
+	_strBuffer.append((const char *)pOctets, iOctets);
+	iWrote = iOctets;
+	return true;
+}
+
+// no-op: content is retained until the fragment is spliced or cleared.
+void Fragment::Close()
+{
+}
+
+// pre-allocate buffer space.
+void Fragment::reserve(size_t iOctets)
+{
+	_strBuffer.reserve(iOctets);
+}
+
+// discard content so the fragment may be reused.
+void Fragment::clear()
+{
+	_strBuffer.resize(0);
+}
+
+// serialized content.
+const char *Fragment::data() const
+{
+	return _strBuffer.data();
+}
+
+size_t Fragment::size() const
+{
+	return _strBuffer.size();
+}
+
+};
\ No newline at end of file
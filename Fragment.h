@@ -0,0 +1,36 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// In-memory output stream holding one serialized document fragment.
+// Exporters may split a large document among worker threads: each worker
+// writes its subtree through its own Writer (see Writer::openFragment) into
+// its own Fragment. Nothing is shared between workers so no locking is needed.
+// The coordinating Writer then splices the fragments into the final stream,
+// in order, with Writer::writeFragment.
+class Fragment : public IOutputStream
+{
+	std::string _strBuffer;
+
+public:
+	Fragment();
+	// appends octets to the buffer.
+	virtual bool Write(unsigned char *pOctets, size_t iOctets, size_t &iWrote);
+	// no-op: content is retained until the fragment is spliced or cleared.
+	virtual void Close();
+	// pre-allocate buffer space.
+	void reserve(size_t iOctets);
+	// discard content so the fragment may be reused.
+	void clear();
+	// serialized content.
+	const char *data() const;
+	size_t size() const;
+};
+
+};
\ No newline at end of file
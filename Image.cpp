@@ -0,0 +1,435 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Image.h"
+#include "Reader.h"
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace XML
+{
+
+// layout: magic, version, source size, source time stamp, name table, then
+// records. Each record begins with its kind:
+// StartElement: name, attribute count, then (name, length, value) per attribute.
+// Text: length, text.
+// EndElement: nothing further.
+// Names are numbers into the name table. Integers are little-endian.
+static const char strMagic[4] = { 'X', 'M', 'L', 'B' };
+static const unsigned long iVersion = 2;
+
+static FILE *openFile(const char *strPath, const char *strMode)
+{
+	FILE *pFile = NULL;
+#ifdef _WIN32
+	if ( fopen_s(&pFile, strPath, strMode) != 0 )
+		pFile = NULL;
+#else
+	pFile = fopen(strPath, strMode);
+#endif
+	return pFile;
+}
+
+// size and modification time of a file. The time keeps the platform's full
+// resolution so a rewrite within the same second still marks an image stale.
+static bool stampFile(const char *strPath, unsigned long long &iSize, unsigned long long &iTime)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if ( !GetFileAttributesExA(strPath, GetFileExInfoStandard, &info) )
+		return false;
+	iSize = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	// 100 nanosecond units.
+	iTime = ((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat info;
+	if ( stat(strPath, &info) != 0 )
+		return false;
+	iSize = (unsigned long long)info.st_size;
+	// nanoseconds.
+#ifdef __APPLE__
+	iTime = (unsigned long long)info.st_mtimespec.tv_sec * 1000000000ULL + info.st_mtimespec.tv_nsec;
+#else
+	iTime = (unsigned long long)info.st_mtim.tv_sec * 1000000000ULL + info.st_mtim.tv_nsec;
+#endif
+#endif
+	return true;
+}
+
+static void put32(std::string &strImage, unsigned long iValue)
+{
+	char octets[4];
+	for (size_t i = 0; i < 4; i++)
+		octets[i] = (char)(iValue >> (i * 8));
+	strImage.append(octets, 4);
+}
+
+static void put64(std::string &strImage, unsigned long long iValue)
+{
+	put32(strImage, (unsigned long)(iValue & 0xFFFFFFFF));
+	put32(strImage, (unsigned long)(iValue >> 32));
+}
+
+static void putText(std::string &strImage, const std::string &strText)
+{
+	put32(strImage, (unsigned long)strText.size());
+	strImage += strText;
+}
+
+// accumulates the name table and records during compilation.
+struct Compiler
+{
+	std::map<std::string, unsigned long> Names;
+	std::vector<const std::string *> Table;
+	std::string Body;
+
+	unsigned long intern(const std::string &strName)
+	{
+		std::pair<std::map<std::string, unsigned long>::iterator, bool> result = 
+			Names.insert( std::make_pair(strName, (unsigned long)Table.size()) );
+		if (result.second)
+			Table.push_back( &(*result.first).first );
+		return (*result.first).second;
+	}
+};
+
+// record an element whose start tag the reader has just consumed, then its content.
+static bool compileElement(Reader &reader, Compiler &compiler)
+{
+	std::string strName, strValue;
+	std::list< std::pair<std::string, std::string> >::iterator it, itEnd;
+	reader.getElementName(strName);
+	compiler.Body += (char)Image::StartElement;
+	put32(compiler.Body, compiler.intern(strName));
+	std::string strAttributes;
+	unsigned long iAttributes = 0;
+	if ( reader.enumAttributes(it, itEnd) )
+	{
+		for ( ; it != itEnd; it++)
+		{
+			// store values with entities already expanded.
+			reader.getAttribute((*it).first.c_str(), strValue);
+			put32(strAttributes, compiler.intern((*it).first));
+			putText(strAttributes, strValue);
+			iAttributes++;
+		}
+	}
+	put32(compiler.Body, iAttributes);
+	compiler.Body += strAttributes;
+	while (true)
+	{
+		// CDATA content becomes ordinary text.
+		std::string strText;
+		bool bText = (reader.readPCData(strText) || reader.readCData(strText)) && strText.size() > 0;
+		if (bText)
+		{
+			compiler.Body += (char)Image::Text;
+			putText(compiler.Body, strText);
+		}
+		if ( reader.readStartElement() )
+		{
+			if ( !compileElement(reader, compiler) )
+				return false;
+		}
+		else if (!bText)
+			break;
+	}
+	compiler.Body += (char)Image::EndElement;
+	return reader.readEndElement(false);
+}
+
+// convert the text document read from pSource into an image file.
+// strSource names the document file, whose size and time stamp the image records.
+bool Image::compile(IInputStream *pSource, const char *strSource, const char *strImage)
+{
+	unsigned long long iSize = 0, iTime = 0;
+	Reader reader;
+	Compiler compiler;
+	bool bOK = stampFile(strSource, iSize, iTime) && reader.open(pSource);
+	while ( bOK && reader.readStartElement() )
+		bOK = compileElement(reader, compiler);
+	if (!bOK)
+		return false;
+
+	std::string strHeader(strMagic, sizeof strMagic);
+	put32(strHeader, iVersion);
+	put64(strHeader, iSize);
+	put64(strHeader, iTime);
+	put32(strHeader, (unsigned long)compiler.Table.size());
+	for (size_t i = 0; i < compiler.Table.size(); i++)
+		putText(strHeader, *compiler.Table[i]);
+
+	FILE *pFile = openFile(strImage, "wb");
+	if (pFile == NULL)
+		return false;
+	bOK = fwrite(strHeader.data(), 1, strHeader.size(), pFile) == strHeader.size() &&
+		fwrite(compiler.Body.data(), 1, compiler.Body.size(), pFile) == compiler.Body.size();
+	bOK = fclose(pFile) == 0 && bOK;
+	if (!bOK)
+		remove(strImage);
+	return bOK;
+}
+
+#ifdef _WIN32
+Image::Image() : _pBase(NULL), _iSize(0), _pCursor(NULL), _pEnd(NULL), 
+	_hFile(INVALID_HANDLE_VALUE), _hMap(NULL)
+{
+}
+#else
+Image::Image() : _pBase(NULL), _iSize(0), _pCursor(NULL), _pEnd(NULL)
+{
+}
+#endif
+
+Image::~Image()
+{
+	close();
+}
+
+// read integers at the cursor; false if the image is truncated.
+bool Image::get32(const unsigned char *&pCursor, unsigned long &iValue) const
+{
+	if (_pEnd - pCursor < 4)
+		return false;
+	iValue = 0;
+	for (size_t i = 0; i < 4; i++)
+		iValue |= (unsigned long)pCursor[i] << (i * 8);
+	pCursor += 4;
+	return true;
+}
+
+bool Image::get64(const unsigned char *&pCursor, unsigned long long &iValue) const
+{
+	unsigned long iLow = 0, iHigh = 0;
+	if ( !get32(pCursor, iLow) || !get32(pCursor, iHigh) )
+		return false;
+	iValue = ((unsigned long long)iHigh << 32) | iLow;
+	return true;
+}
+
+// map an image; fails if missing, malformed or stale relative to strSource.
+bool Image::open(const char *strImage, const char *strSource)
+{
+	unsigned long long iSize = 0, iTime = 0;
+	close();
+	if ( !stampFile(strSource, iSize, iTime) )
+		return false;
+#ifdef _WIN32
+	_hFile = CreateFileA(strImage, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (_hFile == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER size;
+	if ( GetFileSizeEx(_hFile, &size) && size.QuadPart > 0 && (unsigned long long)size.QuadPart <= (size_t)-1 )
+	{
+		_hMap = CreateFileMapping(_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (_hMap != NULL)
+		{
+			_pBase = (const unsigned char *)MapViewOfFile(_hMap, FILE_MAP_READ, 0, 0, 0);
+			_iSize = (size_t)size.QuadPart;
+		}
+	}
+#else
+	int iFile = ::open(strImage, O_RDONLY);
+	if (iFile == -1)
+		return false;
+	struct stat info;
+	if ( fstat(iFile, &info) == 0 && info.st_size > 0 )
+	{
+		void *pMap = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, iFile, 0);
+		if (pMap != MAP_FAILED)
+		{
+			_pBase = (const unsigned char *)pMap;
+			_iSize = (size_t)info.st_size;
+		}
+	}
+	::close(iFile);
+#endif
+	if (_pBase == NULL)
+	{
+		close();
+		return false;
+	}
+
+	// validate header and load the name table.
+	const unsigned char *pCursor = _pBase + sizeof strMagic;
+	unsigned long iFound = 0, iNames = 0;
+	unsigned long long iImageSize = 0, iImageTime = 0;
+	_pEnd = _pBase + _iSize;
+	bool bOK = _iSize >= sizeof strMagic && memcmp(_pBase, strMagic, sizeof strMagic) == 0 &&
+		get32(pCursor, iFound) && iFound == iVersion &&
+		get64(pCursor, iImageSize) && get64(pCursor, iImageTime) &&
+		iImageSize == iSize && iImageTime == iTime &&
+		get32(pCursor, iNames);
+	for (unsigned long i = 0; bOK && i < iNames; i++)
+	{
+		unsigned long iLen = 0;
+		bOK = get32(pCursor, iLen) && (unsigned long)(_pEnd - pCursor) >= iLen;
+		if (bOK)
+		{
+			_names.push_back( std::string((const char *)pCursor, iLen) );
+			pCursor += iLen;
+		}
+	}
+	if (!bOK)
+	{
+		close();
+		return false;
+	}
+	_pCursor = pCursor;
+	return true;
+}
+
+void Image::close()
+{
+#ifdef _WIN32
+	if (_pBase != NULL)
+		UnmapViewOfFile(_pBase);
+	if (_hMap != NULL)
+		CloseHandle(_hMap);
+	if (_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(_hFile);
+	_hMap = NULL;
+	_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (_pBase != NULL)
+		munmap((void *)_pBase, _iSize);
+#endif
+	_pBase = NULL;
+	_iSize = 0;
+	_pCursor = NULL;
+	_pEnd = NULL;
+	_names.clear();
+}
+
+// true if all records have been consumed.
+bool Image::eof() const
+{
+	return _pCursor == _pEnd;
+}
+
+// kind of the next record.
+Image::Kind Image::peek() const
+{
+	if (_pCursor == _pEnd)
+		return End;
+	switch (*_pCursor)
+	{
+		case StartElement:
+			return StartElement;
+		case Text:
+			return Text;
+		case EndElement:
+			return EndElement;
+	}
+	return End;
+}
+
+// true if the next record starts an element with the given name.
+bool Image::peekStart(const char *strElement) const
+{
+	const unsigned char *pCursor = _pCursor + 1;
+	unsigned long iName = 0;
+	return peek() == StartElement && get32(pCursor, iName) && 
+		iName < _names.size() && _names[iName].compare(strElement) == 0;
+}
+
+// consume a start element record.
+bool Image::readStart(std::string &strElement, std::list< std::pair<std::string, std::string> > &attributes)
+{
+	if (peek() != StartElement)
+		return false;
+	const unsigned char *pCursor = _pCursor + 1;
+	unsigned long iName = 0, iAttributes = 0;
+	if ( !get32(pCursor, iName) || iName >= _names.size() || !get32(pCursor, iAttributes) )
+		return false;
+	strElement = _names[iName];
+	attributes.clear();
+	for (unsigned long i = 0; i < iAttributes; i++)
+	{
+		unsigned long iLen = 0;
+		if ( !get32(pCursor, iName) || iName >= _names.size() || 
+			!get32(pCursor, iLen) || (unsigned long)(_pEnd - pCursor) < iLen )
+			return false;
+		attributes.push_back( std::make_pair(_names[iName], std::string((const char *)pCursor, iLen)) );
+		pCursor += iLen;
+	}
+	_pCursor = pCursor;
+	return true;
+}
+
+// consume a text record; the text points into the image.
+bool Image::readText(const char *&pText, size_t &iLen)
+{
+	if (peek() != Text)
+		return false;
+	const unsigned char *pCursor = _pCursor + 1;
+	unsigned long iText = 0;
+	if ( !get32(pCursor, iText) || (unsigned long)(_pEnd - pCursor) < iText )
+		return false;
+	pText = (const char *)pCursor;
+	iLen = iText;
+	_pCursor = pCursor + iText;
+	return true;
+}
+
+// consume an end element record.
+bool Image::readEnd()
+{
+	if (peek() != EndElement)
+		return false;
+	_pCursor++;
+	return true;
+}
+
+// consume any one record.
+bool Image::skip()
+{
+	std::string strElement;
+	std::list< std::pair<std::string, std::string> > attributes;
+	const char *pText = NULL;
+	size_t iLen = 0;
+	switch (peek())
+	{
+		case StartElement:
+			return readStart(strElement, attributes);
+		case Text:
+			return readText(pText, iLen);
+		case EndElement:
+			return readEnd();
+		default:
+			break;
+	}
+	return false;
+}
+
+// consume whitespace-only text records, as the parser skips whitespace
+// between tags. always returns true.
+bool Image::skipSpace()
+{
+	while (peek() == Text)
+	{
+		const unsigned char *pCursor = _pCursor + 1;
+		unsigned long iText = 0;
+		if ( !get32(pCursor, iText) || (unsigned long)(_pEnd - pCursor) < iText )
+			break;
+		for (unsigned long i = 0; i < iText; i++)
+		{
+			if ( !isspace(pCursor[i]) )
+				return true;
+		}
+		_pCursor = pCursor + iText;
+	}
+	return true;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,79 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+#include <list>
+#include <vector>
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Compact pre-parsed form of an XML document for fast repeated loading.
+// compile converts a text document once: element and attribute names are
+// interned, entities are expanded and text (including CDATA) is
+// length-prefixed. open maps the result into memory; a Reader opened on the
+// Image then serves the usual readStartElement / getAttribute / readPCData
+// calls without parsing text.
+// open fails if the image is missing or older than its source document, in
+// which case the application parses the text document as usual.
+//
+//	XML::Image image;
+//	if ( image.open("config.xmlb", "config.xml") )
+//		reader.open(&image);
+//	else if ( istream.Open("config.xml") )
+//		reader.open(&istream);
+class Image
+{
+public:
+	// record types.
+	enum Kind { End = 0, StartElement = 1, Text = 2, EndElement = 3 };
+
+private:
+	// mapped image.
+	const unsigned char *_pBase;
+	size_t _iSize;
+	// cursor into body records.
+	const unsigned char *_pCursor;
+	const unsigned char *_pEnd;
+	// interned names.
+	std::vector<std::string> _names;
+#ifdef _WIN32
+	void *_hFile;
+	void *_hMap;
+#endif
+
+	// read integers at the cursor; false if the image is truncated.
+	bool get32(const unsigned char *&pCursor, unsigned long &iValue) const;
+	bool get64(const unsigned char *&pCursor, unsigned long long &iValue) const;
+
+public:
+	Image();
+	~Image();
+	// convert the text document read from pSource into an image file.
+	// strSource names the document file, whose size and time stamp the image records.
+	static bool compile(IInputStream *pSource, const char *strSource, const char *strImage);
+	// map an image; fails if missing, malformed or stale relative to strSource.
+	bool open(const char *strImage, const char *strSource);
+	void close();
+	// true if all records have been consumed.
+	bool eof() const;
+	// kind of the next record.
+	Kind peek() const;
+	// true if the next record starts an element with the given name.
+	bool peekStart(const char *strElement) const;
+	// consume a start element record.
+	bool readStart(std::string &strElement, std::list< std::pair<std::string, std::string> > &attributes);
+	// consume a text record; the text points into the image.
+	bool readText(const char *&pText, size_t &iLen);
+	// consume an end element record.
+	bool readEnd();
+	// consume any one record.
+	bool skip();
+	// consume whitespace-only text records, as the parser skips whitespace
+	// between tags. always returns true.
+	bool skipSpace();
+};
+
+};
\ No newline at end of file
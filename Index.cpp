@@ -0,0 +1,364 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Index.h"
+#include "Scanner.h"
+#include <string.h>
+#include <ctype.h>
+
+namespace XML
+{
+
+static const char strMagic[4] = { 'X', 'I', 'D', 'X' };
+static const unsigned long iVersion = 1;
+
+static FILE *openFile(const char *strPath, const char *strMode)
+{
+	FILE *pFile = NULL;
+#ifdef _WIN32
+	if ( fopen_s(&pFile, strPath, strMode) != 0 )
+		pFile = NULL;
+#else
+	pFile = fopen(strPath, strMode);
+#endif
+	return pFile;
+}
+
+static bool seekFile(FILE *pFile, unsigned long long iOffset)
+{
+#ifdef _WIN32
+	return _fseeki64(pFile, (__int64)iOffset, SEEK_SET) == 0;
+#else
+	return fseeko(pFile, (off_t)iOffset, SEEK_SET) == 0;
+#endif
+}
+
+// sidecar integers are little-endian regardless of platform.
+static bool write32(FILE *pFile, unsigned long iValue)
+{
+	unsigned char octets[4];
+	for (size_t i = 0; i < 4; i++)
+		octets[i] = (unsigned char)(iValue >> (i * 8));
+	return fwrite(octets, 1, 4, pFile) == 4;
+}
+
+static bool write64(FILE *pFile, unsigned long long iValue)
+{
+	return write32(pFile, (unsigned long)(iValue & 0xFFFFFFFF)) && write32(pFile, (unsigned long)(iValue >> 32));
+}
+
+static bool writeText(FILE *pFile, const std::string &strText)
+{
+	return write32(pFile, (unsigned long)strText.size()) && 
+		fwrite(strText.data(), 1, strText.size(), pFile) == strText.size();
+}
+
+static bool read32(FILE *pFile, unsigned long &iValue)
+{
+	unsigned char octets[4];
+	if ( fread(octets, 1, 4, pFile) != 4 )
+		return false;
+	iValue = 0;
+	for (size_t i = 0; i < 4; i++)
+		iValue |= (unsigned long)octets[i] << (i * 8);
+	return true;
+}
+
+static bool read64(FILE *pFile, unsigned long long &iValue)
+{
+	unsigned long iLow = 0, iHigh = 0;
+	if ( !read32(pFile, iLow) || !read32(pFile, iHigh) )
+		return false;
+	iValue = ((unsigned long long)iHigh << 32) | iLow;
+	return true;
+}
+
+static bool readText(FILE *pFile, std::string &strText)
+{
+	unsigned long iLen = 0;
+	if ( !read32(pFile, iLen) )
+		return false;
+	strText.resize(iLen);
+	return iLen == 0 || fread(&strText[0], 1, iLen, pFile) == iLen;
+}
+
+// attribute value from tag text, as written.
+static bool tagAttribute(const std::string &strTag, const char *strAttribute, std::string &strValue)
+{
+	std::string strName;
+	// step past '<' and the element name.
+	Scanner::getName(strTag, strName);
+	size_t i = 1 + strName.size();
+	while (i < strTag.size())
+	{
+		while ( i < strTag.size() && isspace((unsigned char)strTag[i]) ) i++;
+		if ( i >= strTag.size() || strTag[i] == '/' || strTag[i] == '>' )
+			break;
+		// attribute name.
+		size_t iName = i;
+		while ( i < strTag.size() && strTag[i] != '=' && strTag[i] != '/' && strTag[i] != '>' &&
+			!isspace((unsigned char)strTag[i]) )
+			i++;
+		strName.assign(strTag, iName, i - iName);
+		while ( i < strTag.size() && isspace((unsigned char)strTag[i]) ) i++;
+		if ( i >= strTag.size() || strTag[i] != '=' )
+		{
+			// malformed: a name without a value.
+			if (i == iName)
+				i++;
+			continue;
+		}
+		i++;
+		while ( i < strTag.size() && isspace((unsigned char)strTag[i]) ) i++;
+		if ( i >= strTag.size() || (strTag[i] != '"' && strTag[i] != '\'') )
+			break;
+		// quoted value; its content is never taken for attribute names.
+		size_t iEnd = strTag.find(strTag[i], i + 1);
+		if (iEnd == std::string::npos)
+			break;
+		if ( strName.compare(strAttribute) == 0 )
+		{
+			strValue.assign(strTag, i + 1, iEnd - i - 1);
+			return true;
+		}
+		i = iEnd + 1;
+	}
+	return false;
+}
+
+// scan a document from its first octet, recording every outermost element
+// named strElement. strKey optionally names an attribute to look records up by.
+bool Index::build(IInputStream *pStream, const char *strElement, const char *strKey)
+{
+	Scanner scanner;
+	// names of open elements.
+	std::vector<std::string> stack;
+	// text of the tag being scanned.
+	std::string strTag, strName;
+	std::vector<unsigned char> block(65536);
+	// stream offset of the first octet in block.
+	unsigned long long iBase = 0;
+	// stream offset of the current tag.
+	unsigned long long iStart = 0;
+	// element depth of the open record; zero if none.
+	size_t iDepth = 0;
+	Record record;
+	size_t iRead = 0;
+
+	_records.clear();
+	_keys.clear();
+	while ( pStream->Read(&block[0], block.size(), iRead) && iRead > 0 )
+	{
+		const unsigned char *pBlock = &block[0];
+		size_t i = 0;
+		while (i < iRead)
+		{
+			if ( scanner.isText() )
+			{
+				// fast skip: text runs until the next '<'.
+				const void *pOpen = memchr(pBlock + i, '<', iRead - i);
+				if (pOpen == NULL)
+					break;
+				i = (const unsigned char *)pOpen - pBlock;
+				iStart = iBase + i;
+				strTag.resize(0);
+			}
+			char ch = (char)pBlock[i++];
+			Scanner::Markup markup = scanner.scan(ch);
+			if ( scanner.isTag() || markup == Scanner::StartTag || 
+				markup == Scanner::EmptyTag || markup == Scanner::EndTag )
+				strTag += ch;
+			switch (markup)
+			{
+				case Scanner::StartTag:
+				case Scanner::EmptyTag:
+					Scanner::getName(strTag, strName);
+					if ( iDepth == 0 && strName.compare(strElement) == 0 )
+					{
+						record.Offset = iStart;
+						record.Context.resize(0);
+						for (size_t j = 0; j < stack.size(); j++)
+						{
+							if (j > 0)
+								record.Context += '/';
+							record.Context += stack[j];
+						}
+						record.Key.resize(0);
+						if (strKey != NULL)
+							tagAttribute(strTag, strKey, record.Key);
+						if (markup == Scanner::EmptyTag)
+						{
+							record.Length = iBase + i - record.Offset;
+							_records.push_back(record);
+						}
+						else
+							iDepth = stack.size() + 1;
+					}
+					if (markup == Scanner::StartTag)
+						stack.push_back(strName);
+					break;
+				case Scanner::EndTag:
+					if (stack.size() > 0)
+						stack.pop_back();
+					if ( iDepth > 0 && stack.size() < iDepth )
+					{
+						record.Length = iBase + i - record.Offset;
+						_records.push_back(record);
+						iDepth = 0;
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		iBase += iRead;
+	}
+	for (size_t i = 0; i < _records.size(); i++)
+	{
+		if (_records[i].Key.size() > 0)
+			_keys.insert( std::make_pair(_records[i].Key, i) );
+	}
+	return iDepth == 0;
+}
+
+// write the index to a sidecar file.
+// layout: magic, version, context names, then per record:
+// offset, length, context number and key.
+bool Index::save(const char *strPath) const
+{
+	FILE *pFile = openFile(strPath, "wb");
+	if (pFile == NULL)
+		return false;
+	// contexts repeat heavily so each is written once and referred to by number.
+	std::map<std::string, unsigned long> contexts;
+	std::vector<const std::string *> names;
+	for (size_t i = 0; i < _records.size(); i++)
+	{
+		if ( contexts.insert( std::make_pair(_records[i].Context, (unsigned long)names.size()) ).second )
+			names.push_back(&_records[i].Context);
+	}
+	bool bOK = fwrite(strMagic, 1, sizeof strMagic, pFile) == sizeof strMagic &&
+		write32(pFile, iVersion) && 
+		write32(pFile, (unsigned long)names.size());
+	for (size_t i = 0; bOK && i < names.size(); i++)
+		bOK = writeText(pFile, *names[i]);
+	bOK = bOK && write64(pFile, _records.size());
+	for (size_t i = 0; bOK && i < _records.size(); i++)
+	{
+		const Record &record = _records[i];
+		bOK = write64(pFile, record.Offset) && 
+			write64(pFile, record.Length) &&
+			write32(pFile, contexts[record.Context]) &&
+			writeText(pFile, record.Key);
+	}
+	return fclose(pFile) == 0 && bOK;
+}
+
+// read an index from a sidecar file.
+bool Index::load(const char *strPath)
+{
+	_records.clear();
+	_keys.clear();
+	FILE *pFile = openFile(strPath, "rb");
+	if (pFile == NULL)
+		return false;
+	char magic[4] = {0};
+	unsigned long iFound = 0, iNames = 0;
+	unsigned long long iRecords = 0;
+	bool bOK = fread(magic, 1, sizeof magic, pFile) == sizeof magic &&
+		memcmp(magic, strMagic, sizeof magic) == 0 &&
+		read32(pFile, iFound) && iFound == iVersion &&
+		read32(pFile, iNames);
+	std::vector<std::string> names;
+	for (unsigned long i = 0; bOK && i < iNames; i++)
+	{
+		names.push_back(std::string());
+		bOK = readText(pFile, names.back());
+	}
+	bOK = bOK && read64(pFile, iRecords);
+	for (unsigned long long i = 0; bOK && i < iRecords; i++)
+	{
+		Record record;
+		unsigned long iContext = 0;
+		bOK = read64(pFile, record.Offset) && 
+			read64(pFile, record.Length) &&
+			read32(pFile, iContext) && iContext < names.size() &&
+			readText(pFile, record.Key);
+		if (bOK)
+		{
+			record.Context = names[iContext];
+			if (record.Key.size() > 0)
+				_keys.insert( std::make_pair(record.Key, _records.size()) );
+			_records.push_back(record);
+		}
+	}
+	fclose(pFile);
+	if (!bOK)
+	{
+		_records.clear();
+		_keys.clear();
+	}
+	return bOK;
+}
+
+// number of records.
+size_t Index::size() const
+{
+	return _records.size();
+}
+
+// retrieve record by number; NULL if out of range.
+const Index::Record *Index::find(size_t iRecord) const
+{
+	return iRecord < _records.size() ? &_records[iRecord] : NULL;
+}
+
+// retrieve record by key; NULL if not found.
+const Index::Record *Index::find(const char *strKey) const
+{
+	std::map<std::string, size_t>::const_iterator it = _keys.find(strKey);
+	return it != _keys.end() ? &_records[(*it).second] : NULL;
+}
+
+RecordStream::RecordStream() : _pFile(NULL), _iLeft(0)
+{
+}
+
+RecordStream::~RecordStream()
+{
+	Close();
+}
+
+bool RecordStream::Open(const char *strPath, const Index::Record &record)
+{
+	Close();
+	_pFile = openFile(strPath, "rb");
+	if ( _pFile != NULL && seekFile(_pFile, record.Offset) )
+	{
+		_iLeft = record.Length;
+		return true;
+	}
+	Close();
+	return false;
+}
+
+bool RecordStream::Read(unsigned char *pOctets, size_t iOctets, size_t &iRead)
+{
+	iRead = 0;
+	if (_pFile == NULL || _iLeft == 0)
+		return false;
+	if (iOctets > _iLeft)
+		iOctets = (size_t)_iLeft;
+	iRead = fread(pOctets, 1, iOctets, _pFile);
+	_iLeft -= iRead;
+	return iRead > 0;
+}
+
+void RecordStream::Close()
+{
+	if (_pFile != NULL)
+		fclose(_pFile);
+	_pFile = NULL;
+	_iLeft = 0;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Sidecar index of record offsets for random access into large XML files.
+// build scans a document once, noting where each chosen element begins and
+// ends; save / load keep the index in a compact binary file beside the document.
+// A RecordStream then seeks straight to one record so that a Reader can parse
+// just that subtree.
+class Index
+{
+public:
+	struct Record
+	{
+		// octet offset of the record's opening '<'.
+		unsigned long long Offset;
+		// octets through the record's closing '>'.
+		unsigned long long Length;
+		// enclosing element names, '/' separated, eg. "Archive/Records".
+		std::string Context;
+		// key attribute value as written, if any.
+		std::string Key;
+
+		Record() : Offset(0), Length(0) { };
+	};
+
+private:
+	std::vector<Record> _records;
+	// key to record number.
+	std::map<std::string, size_t> _keys;
+
+public:
+	// scan a document from its first octet, recording every outermost element
+	// named strElement. strKey optionally names an attribute to look records up by.
+	bool build(IInputStream *pStream, const char *strElement, const char *strKey);
+	// write the index to a sidecar file.
+	bool save(const char *strPath) const;
+	// read an index from a sidecar file.
+	bool load(const char *strPath);
+	// number of records.
+	size_t size() const;
+	// retrieve record by number; NULL if out of range.
+	const Record *find(size_t iRecord) const;
+	// retrieve record by key; NULL if not found.
+	const Record *find(const char *strKey) const;
+};
+
+// input stream over one indexed record of a document file.
+// seeks directly to the record and ends with it; open a Reader on it as usual.
+class RecordStream : public IInputStream
+{
+	FILE *_pFile;
+	// octets of the record not yet read.
+	unsigned long long _iLeft;
+
+public:
+	RecordStream();
+	~RecordStream();
+	bool Open(const char *strPath, const Index::Record &record);
+	virtual bool Read(unsigned char *pOctets, size_t iOctets, size_t &iRead);
+	virtual void Close();
+};
+
+};
\ No newline at end of file
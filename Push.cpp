@@ -0,0 +1,88 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Push.h"
+#include <string.h>
+
+namespace XML
+{
+
+PushStream::PushStream() : _iRead(0), _iScanned(0), _iReady(0), _bFinished(false)
+{
+}
+
+// append newly arrived octets.
+void PushStream::feed(const unsigned char *pOctets, size_t iOctets)
+{
+	_strBuffer.append((const char *)pOctets, iOctets);
+	while (_iScanned < _strBuffer.size())
+	{
+		if ( _scanner.scan(_strBuffer[_iScanned++]) != Scanner::None )
+			_iReady = _iScanned;
+	}
+	if (_bFinished)
+		_iReady = _strBuffer.size();
+}
+
+// no more octets will arrive: release whatever remains.
+void PushStream::finish()
+{
+	_bFinished = true;
+	_iReady = _strBuffer.size();
+}
+
+// number of octets that may be released to the parser.
+size_t PushStream::available() const
+{
+	return _iReady - _iRead;
+}
+
+// true if no octets may be released and more are expected.
+bool PushStream::starved() const
+{
+	return !_bFinished && available() == 0;
+}
+
+// true if finish was called.
+bool PushStream::finished() const
+{
+	return _bFinished;
+}
+
+// copies out released octets only. Returns true with zero octets read
+// while starved; returns false once finished and drained.
+bool PushStream::Read(unsigned char *pOctets, size_t iOctets, size_t &iRead)
+{
+	iRead = available();
+	if (iRead > iOctets)
+		iRead = iOctets;
+	memcpy(pOctets, _strBuffer.data() + _iRead, iRead);
+	_iRead += iRead;
+	// reclaim consumed octets once they dominate the buffer.
+	if (_iRead >= 4096 && _iRead * 2 >= _strBuffer.size())
+	{
+		_strBuffer.erase(0, _iRead);
+		_iScanned -= _iRead;
+		_iReady -= _iRead;
+		_iRead = 0;
+	}
+	return iRead > 0 || !_bFinished;
+}
+
+// no-op: buffered octets survive the parser closing or re-opening
+// this stream, so the Reader may re-arm its parser at any time.
+void PushStream::Close()
+{
+}
+
+// discard buffered octets and start over with a new document.
+void PushStream::reset()
+{
+	_strBuffer.resize(0);
+	_scanner.reset();
+	_iRead = 0;
+	_iScanned = 0;
+	_iReady = 0;
+	_bFinished = false;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+#include "Scanner.h"
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Push-fed input stream for non-blocking sources such as sockets.
+// The application feeds octets as they arrive instead of the parser pulling
+// them. Only complete markup (and the text preceding it) is released to the
+// parser, so the parser never sees half a tag; the incomplete tail is held
+// back until more octets arrive or the stream is finished.
+class PushStream : public IInputStream
+{
+	Scanner _scanner;
+	// octets fed but not yet read.
+	std::string _strBuffer;
+	// read position in buffer.
+	size_t _iRead;
+	// scan position in buffer.
+	size_t _iScanned;
+	// octets before this position may be released to the parser.
+	size_t _iReady;
+	// true when no more octets will be fed.
+	bool _bFinished;
+
+public:
+	PushStream();
+	// append newly arrived octets.
+	void feed(const unsigned char *pOctets, size_t iOctets);
+	// no more octets will arrive: release whatever remains.
+	void finish();
+	// number of octets that may be released to the parser.
+	size_t available() const;
+	// true if no octets may be released and more are expected.
+	bool starved() const;
+	// true if finish was called.
+	bool finished() const;
+	// copies out released octets only. Returns true with zero octets read
+	// while starved; returns false once finished and drained.
+	virtual bool Read(unsigned char *pOctets, size_t iOctets, size_t &iRead);
+	// no-op: buffered octets survive the parser closing or re-opening
+	// this stream, so the Reader may re-arm its parser at any time.
+	virtual void Close();
+	// discard buffered octets and start over with a new document.
+	void reset();
+};
+
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 // Copyright  2008-2011 Rick Parrish
 
 #include "Reader.h"
+#include "Base64.h"
 #include <tchar.h>
 
 namespace XML
@@ -84,18 +85,24 @@ static void readEntities(const std::string &strValue, std::string &strResult)
 	}
 }
 
-static void readEntities(const std::string &strValue, std::wstring &strResult)
+// transcode UTF-8 or ASCII text to wide characters.
+static void transcode(const std::string &strMulti, std::wstring &strResult)
 {
 	size_t size = 0;
-	std::string strMulti;
-	
-	readEntities(strValue, strMulti);
 	strResult.resize(strMulti.size());
 	mbstowcs_s(&size, &strResult[0], strResult.size(), strMulti.c_str(), strMulti.size());
 	strResult.resize(size);
 }
 
-Reader::Reader() : _bStart(false), _iSkipped(0)
+static void readEntities(const std::string &strValue, std::wstring &strResult)
+{
+	std::string strMulti;
+	
+	readEntities(strValue, strMulti);
+	transcode(strMulti, strResult);
+}
+
+Reader::Reader() : _bStart(false), _iSkipped(0), _pPush(NULL), _pImage(NULL), _bValidate(false)
 {
 }
 
@@ -104,14 +111,92 @@ bool Reader::open(IInputStream *pStream)
 {
 	_bStart = false;
 	_iSkipped = 0;
+	_pPush = NULL;
+	_pImage = NULL;
+	_bValidate = false;
 	return _parser.open(pStream);
 }
 
+// connect parser to an input stream, optionally validating it as it is read.
+bool Reader::open(IInputStream *pStream, bool bValidate)
+{
+	if (!bValidate)
+		return open(pStream);
+	bool bOK = _validator.open(pStream) && open(&_validator);
+	_bValidate = true;
+	return bOK;
+}
+
+// validation mode: true if an error was found, with its octet offset and line.
+bool Reader::getError(std::string &strError, unsigned long long &iOffset, size_t &iLine) const
+{
+	if (!_bValidate)
+		return false;
+	return _validator.getError(strError, iOffset, iLine);
+}
+
+// read from a pre-parsed image instead of XML text.
+bool Reader::open(Image *pImage)
+{
+	_bStart = false;
+	_iSkipped = 0;
+	_pPush = NULL;
+	_pImage = pImage;
+	_bValidate = false;
+	return _pImage != NULL;
+}
+
+// connect parser to a push-fed stream.
+bool Reader::open(PushStream *pStream)
+{
+	bool bOK = open( (IInputStream *)pStream );
+	_pPush = pStream;
+	return bOK;
+}
+
+// push-mode: supply newly arrived octets.
+bool Reader::feed(const unsigned char *pOctets, size_t iOctets)
+{
+	if (_pPush == NULL)
+		return false;
+	_pPush->feed(pOctets, iOctets);
+	return rearm();
+}
+
+// push-mode: no more octets will arrive.
+bool Reader::finish()
+{
+	if (_pPush == NULL)
+		return false;
+	_pPush->finish();
+	return rearm();
+}
+
+// push-mode: re-open the parser if its read-ahead buffer ran dry while
+// released octets wait in the push stream. the buffer is empty at that
+// point so re-opening loses nothing and clears the end of stream condition.
+// PushStream::Close is a no-op, so re-opening keeps the octets not yet read.
+bool Reader::rearm()
+{
+	if ( _pPush != NULL && _parser.eof() && _pPush->available() > 0 )
+		return _parser.open(_pPush);
+	return true;
+}
+
+// push-mode: true if the parser has run out of input but more is expected.
+bool Reader::starved()
+{
+	return _pPush != NULL && !_pPush->finished() && _parser.eof() && _pPush->available() == 0;
+}
+
 // close parsing
 void Reader::close()
 {
 	_parser.close();
 	_bStart = false;
+	_pPush = NULL;
+	_pImage = NULL;
+	_bValidate = false;
 }
 
 // True if parser has reached end of stream
@@ -120,6 +205,9 @@ void Reader::close()
 // EOF true here means the parser has reached the end of the stream.
 bool Reader::eof()
 {
+	if (_pImage != NULL)
+		return _pImage->eof();
+	rearm();
 	return _parser.eof();
 }
 
@@ -144,11 +232,14 @@ bool Reader::parseToken(std::string &strToken)
 // returns true if start of an element.
 bool Reader::isStartElement()
 {
+	if (_pImage != NULL)
+		return _pImage->skipSpace() && _pImage->peek() == Image::StartElement;
+	rearm();
 	if ( _parser.eof() ) return false;
 	if (_bStart)
 		return true;
 	skipspace(false);
-	_bStart = _parser.peekMatch('<') && !_parser.peekMatch("</");
+	_bStart = _parser.peekMatch('<') && !_parser.peekMatch("</") && !_parser.peekMatch("<![CDATA[");
 	if (_bStart) _parser.consume(1);
 	return _bStart;
 }
@@ -156,6 +247,8 @@ bool Reader::isStartElement()
 // returns true if start of the named element.
 bool Reader::isStartElement(const char *strElement)
 {
+	if (_pImage != NULL)
+		return _pImage->skipSpace() && _pImage->peekStart(strElement);
 	return isStartElement() && _parser.peekMatch(strElement);
 }
 
@@ -163,6 +256,8 @@ bool Reader::isStartElement(const char *strElement)
 // if true, the element's attributes are available below through getAttribute.
 bool Reader::readStartElement()
 {
+	if (_pImage != NULL)
+		return readImageStart();
 	entry element;
 	if ( isStartElement() && parseToken(element.Element) )
 	{
@@ -180,6 +275,8 @@ bool Reader::readStartElement()
 // if true, the element's attributes are available below through getAttribute.
 bool Reader::readStartElement(const char *strElement)
 {
+	if (_pImage != NULL)
+		return _pImage->skipSpace() && _pImage->peekStart(strElement) && readImageStart();
 	entry element;
 	size_t iLen = 0;
 	if ( isStartElement() && _parser.parseMatch(strElement, iLen) )
@@ -199,6 +296,9 @@ bool Reader::readStartElement(const char *strElement)
 // eg. cursor is positioned at the closing tag.
 bool Reader::isEndElement()
 {
+	if (_pImage != NULL)
+		return _stack.size() > 0 && _pImage->skipSpace() && _pImage->peek() == Image::EndElement;
+	rearm();
 	if (_stack.size() > 0)
 	{
 		bool bChildren = _stack.back().Children;
@@ -213,6 +313,9 @@ bool Reader::isEndElement()
 // conclude self-closing element OR consume closing element.
 bool Reader::readEndElement(bool bSkip)
 {
+	if (_pImage != NULL)
+		return readImageEnd(bSkip);
+	rearm();
 	bool bOK = false;
 	if (_stack.size() > 0)
 	{
@@ -231,13 +334,16 @@ bool Reader::readEndElement(bool bSkip)
 				bOK = _parser.parseMatch(strTail.c_str());
 				if (!bOK && bSkip)
 				{
+					std::string strSkipped;
 					if ( readStartElement() )
 					{
 						_stack.back().Skipped++;
 						_iSkipped++;
 						readEndElement(bSkip); // recursive
 					}
-					else break;
+					else if ( !readCData(strSkipped) )
+						break;
+					skipspace(false);
 				}
 				else break;
 			}
@@ -285,6 +391,9 @@ bool Reader::readStringElement(const char *strElement, std::wstring &strValue)
 // retrieve PC Data (free text nodes under an element).
 bool Reader::readPCData(std::string &strData)
 {
+	if (_pImage != NULL)
+		return readImageText(strData);
+	rearm();
 	bool bOK = false;
 	if (_stack.size() > 0 && _stack.back().Children)
 	{
@@ -300,6 +409,15 @@ bool Reader::readPCData(std::string &strData)
 // retrieve PC Data (free text nodes under an element).
 bool Reader::readPCData(std::wstring &strData)
 {
+	if (_pImage != NULL)
+	{
+		std::string strText;
+		bool bOK = readImageText(strText);
+		if (bOK)
+			transcode(strText, strData);
+		return bOK;
+	}
+	rearm();
 	bool bOK = false;
 	if (_stack.size() > 0 && _stack.back().Children)
 	{
@@ -312,6 +430,248 @@ bool Reader::readPCData(std::wstring &strData)
 	return bOK;
 }
 
+// retrieve a CDATA section's content as-is; no entities are expanded.
+// adjacent sections are concatenated.
+bool Reader::readCData(std::string &strData)
+{
+	if (_pImage != NULL)
+		return readImageText(strData);
+	rearm();
+	if ( _stack.size() == 0 || !_stack.back().Children || !_parser.parseMatch("<![CDATA[") )
+		return false;
+	strData.resize(0);
+	while ( !_parser.eof() )
+	{
+		// bulk copy up to the next ']' then test for the terminator.
+		std::string strText;
+		_parser.readText(strText, ']');
+		strData += strText;
+		// adjacent sections (eg. split around "]]>") read as one.
+		if ( _parser.parseMatch("]]>") && !_parser.parseMatch("<![CDATA[") )
+			return true;
+		if ( _parser.parseMatch(']') )
+			strData += ']';
+	}
+	return false;
+}
+
+// retrieve a CDATA section's content as-is; no entities are expanded.
+// adjacent sections are concatenated.
+bool Reader::readCData(std::wstring &strData)
+{
+	std::string strText;
+	bool bOK = readCData(strText);
+	if (bOK)
+		transcode(strText, strData);
+	return bOK;
+}
+
+// image counterpart of readStartElement.
+bool Reader::readImageStart()
+{
+	entry element;
+	if ( _pImage->skipSpace() && _pImage->readStart(element.Element, _attributes) )
+	{
+		// images have no self-closing form: every element may hold content.
+		element.Children = true;
+		_stack.push_back(element);
+		return true;
+	}
+	return false;
+}
+
+// image counterpart of readEndElement.
+bool Reader::readImageEnd(bool bSkip)
+{
+	if (_stack.size() == 0)
+		return false;
+	// skip nested content, counting skipped elements as the parser does.
+	size_t iDepth = 0;
+	while ( bSkip && (iDepth > 0 || _pImage->peek() != Image::EndElement) )
+	{
+		Image::Kind kind = _pImage->peek();
+		if ( kind == Image::StartElement )
+		{
+			if (iDepth == 0)
+				_stack.back().Skipped++;
+			_iSkipped++;
+			iDepth++;
+		}
+		else if ( kind == Image::EndElement )
+			iDepth--;
+		if ( !_pImage->skip() )
+			return false;
+	}
+	if ( _pImage->skipSpace() && _pImage->readEnd() )
+	{
+		_stack.pop_back();
+		return true;
+	}
+	return false;
+}
+
+// image counterpart of readPCData.
+bool Reader::readImageText(std::string &strData)
+{
+	const char *pText = NULL;
+	size_t iLen = 0;
+	bool bOK = _stack.size() > 0 && _pImage->readText(pText, iLen);
+	if (bOK)
+		strData.assign(pText, iLen);
+	return bOK;
+}
+
+// octets of PC Data handed to a sink at a time.
+static const size_t iChunk = 16384;
+
+// read raw text up to the next '<', stopping after about iMax octets
+// but never inside an entity reference.
+// the parser offers no bounded bulk read, so octets are gathered into a
+// local run and appended to the chunk a run at a time.
+bool Reader::readChunk(std::string &strChunk, size_t iMax)
+{
+	char chRun[256];
+	size_t iRun = 0;
+	bool bEntity = false;
+	rearm();
+	strChunk.resize(0);
+	int ch = _parser.peek();
+	while ( !(ch < 0) && ch != '<' )
+	{
+		size_t iSize = strChunk.size() + iRun;
+		// stray ampersands must not hold up the chunk indefinitely.
+		if ( iSize >= iMax && (!bEntity || iSize >= iMax + 32) )
+			break;
+		if (ch == '&')
+			bEntity = true;
+		else if (ch == ';')
+			bEntity = false;
+		chRun[iRun++] = (char)ch;
+		if (iRun == sizeof chRun)
+		{
+			strChunk.append(chRun, iRun);
+			iRun = 0;
+		}
+		_parser.consume(1);
+		ch = _parser.peek();
+	}
+	strChunk.append(chRun, iRun);
+	return strChunk.size() > 0;
+}
+
+// stream PC Data to a sink in bounded chunks, entities expanded.
+// returns false if there is no text, as the other readPCData calls do.
+bool Reader::readPCData(IOutputStream *pSink)
+{
+	bool bOK = _stack.size() > 0 && _stack.back().Children;
+	if (bOK && _pImage != NULL)
+	{
+		// image text is already expanded and in memory.
+		const char *pText = NULL;
+		size_t iLen = 0, iWrote = 0;
+		bOK = _pImage->readText(pText, iLen) &&
+			pSink->Write( (unsigned char *)pText, iLen, iWrote );
+	}
+	else if (bOK)
+	{
+		std::string strRaw, strText;
+		strRaw.reserve(iChunk + 32);
+		bool bText = false;
+		while ( bOK && readChunk(strRaw, iChunk) )
+		{
+			size_t iWrote = 0;
+			bText = true;
+			strText.resize(0);
+			readEntities(strRaw, strText);
+			bOK = pSink->Write( (unsigned char *)strText.data(), strText.size(), iWrote );
+		}
+		bOK = bOK && bText;
+	}
+	return bOK;
+}
+
+// stream a CDATA section's content to a sink in bounded chunks, as-is.
+// adjacent sections are concatenated.
+bool Reader::readCData(IOutputStream *pSink)
+{
+	bool bOK = _stack.size() > 0 && _stack.back().Children;
+	if (bOK && _pImage != NULL)
+	{
+		// image text is already in memory.
+		const char *pText = NULL;
+		size_t iLen = 0, iWrote = 0;
+		return _pImage->readText(pText, iLen) &&
+			pSink->Write( (unsigned char *)pText, iLen, iWrote );
+	}
+	rearm();
+	if ( !bOK || !_parser.parseMatch("<![CDATA[") )
+		return false;
+	std::string strChunk;
+	strChunk.reserve(iChunk);
+	int ch = _parser.peek();
+	while ( bOK && !(ch < 0) )
+	{
+		size_t iWrote = 0;
+		if ( ch == ']' && _parser.parseMatch("]]>") )
+		{
+			// adjacent sections (eg. split around "]]>") read as one.
+			if ( !_parser.parseMatch("<![CDATA[") )
+				return strChunk.size() == 0 ||
+					pSink->Write( (unsigned char *)strChunk.data(), strChunk.size(), iWrote );
+		}
+		else
+		{
+			strChunk += (char)ch;
+			_parser.consume(1);
+			if (strChunk.size() >= iChunk)
+			{
+				bOK = pSink->Write( (unsigned char *)strChunk.data(), strChunk.size(), iWrote );
+				strChunk.resize(0);
+			}
+		}
+		ch = _parser.peek();
+	}
+	return false;
+}
+
+// stream-decode base64 PC Data to a sink in bounded chunks.
+bool Reader::readBase64(IOutputStream *pSink)
+{
+	bool bOK = _stack.size() > 0 && _stack.back().Children;
+	if (bOK)
+	{
+		Base64 decoder;
+		std::string strRaw, strOctets;
+		strRaw.reserve(iChunk + 32);
+		strOctets.reserve(iChunk);
+		if (_pImage != NULL)
+		{
+			const char *pText = NULL;
+			size_t iLen = 0;
+			// decode image text a chunk at a time.
+			if ( _pImage->readText(pText, iLen) )
+			{
+				for (size_t i = 0; bOK && i < iLen; i += iChunk)
+				{
+					size_t iWrote = 0;
+					strOctets.resize(0);
+					bOK = decoder.decode(pText + i, iLen - i < iChunk ? iLen - i : iChunk, strOctets) &&
+						pSink->Write( (unsigned char *)strOctets.data(), strOctets.size(), iWrote );
+				}
+			}
+		}
+		else while ( bOK && readChunk(strRaw, iChunk) )
+		{
+			size_t iWrote = 0;
+			strOctets.resize(0);
+			bOK = decoder.decode(strRaw.data(), strRaw.size(), strOctets) &&
+				pSink->Write( (unsigned char *)strOctets.data(), strOctets.size(), iWrote );
+		}
+		bOK = bOK && decoder.finish();
+	}
+	return bOK;
+}
+
 // skips / consumes whitespace.
 // bInside - true if inside an element declaration eg. between '<' and '>'.
 bool Reader::skipspace(bool bInside)
@@ -383,7 +743,11 @@ bool Reader::getAttribute(const char *strAttribute, std::string &strValue)
 		if ( (*it).first.compare(strAttribute) == 0)
 		{
 			// expand entities only when value is requested.
-			readEntities((*it).second, strValue);
+			// image values were expanded during compilation.
+			if (_pImage != NULL)
+				strValue = (*it).second;
+			else
+				readEntities((*it).second, strValue);
 			return true;
 		}
 		it++;
@@ -401,7 +765,11 @@ bool Reader::getAttribute(const char *strAttribute, std::wstring &strValue)
 		if ( (*it).first.compare(strAttribute) == 0)
 		{
 			// expand entities only when value is requested.
-			readEntities((*it).second, strValue);
+			// image values were expanded during compilation.
+			if (_pImage != NULL)
+				transcode((*it).second, strValue);
+			else
+				readEntities((*it).second, strValue);
 			return true;
 		}
 		it++;
@@ -436,4 +804,10 @@ size_t Reader::getSkipped(bool bDocument) const
 	return _stack.back().Skipped;
 }
 
+// number of open elements.
+size_t Reader::getDepth() const
+{
+	return _stack.size();
+}
+
 };
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <vector>
 #include <list>
 #include "../Stream/Parser.h"
+#include "Push.h"
+#include "Image.h"
+#include "Validator.h"
 
 #pragma once
 
@@ -38,13 +41,30 @@ class Reader
 	bool _bStart;
 	// number of skipped elements.
 	size_t _iSkipped;
+	// push-fed stream, if any.
+	PushStream *_pPush;
+	// pre-parsed image, if any; replaces the parser.
+	Image *_pImage;
+	// checks input in validation mode.
+	Validator _validator;
+	bool _bValidate;
 
 	// recursive descent parsing functions:
 
+	// push-mode: re-open the parser once its read-ahead buffer runs dry
+	// while released octets wait in the push stream.
+	bool rearm();
 	// parse a token
 	bool parseToken(std::string &strToken);
 	// parse attribute=quoted-value sequence.
 	bool parseAttribute();
+	// read raw text up to the next '<', stopping after about iMax octets
+	// but never inside an entity reference.
+	bool readChunk(std::string &strChunk, size_t iMax);
+	// image counterparts of readStartElement, readEndElement and readPCData.
+	bool readImageStart();
+	bool readImageEnd(bool bSkip);
+	bool readImageText(std::string &strData);
 	// skips / consumes whitespace.
 	// bInside - true if inside an element declaration eg. between '<' and '>'.
 	bool skipspace(bool bInside);
@@ -53,6 +73,26 @@ public:
 	Reader();
 	// connect parser to an input stream.
 	bool open(IInputStream *pStream);
+	// connect parser to a push-fed stream.
+	// Octets are then supplied through feed as they arrive. When a call returns
+	// false, starved distinguishes "need more data" from a genuine mismatch.
+	// Since only complete markup reaches the parser, a starved call consumes
+	// nothing and may simply be repeated after the next feed. Composite calls
+	// (readStringElement, readEndElement with skipping) may stop part way.
+	bool open(PushStream *pStream);
+	// connect parser to an input stream, optionally validating it as it is read:
+	// UTF-8 encoding, illegal characters and tag balance. see getError.
+	bool open(IInputStream *pStream, bool bValidate);
+	// validation mode: true if an error was found, with its octet offset and line.
+	bool getError(std::string &strError, unsigned long long &iOffset, size_t &iLine) const;
+	// read from a pre-parsed image instead of XML text.
+	bool open(Image *pImage);
+	// push-mode: supply newly arrived octets.
+	bool feed(const unsigned char *pOctets, size_t iOctets);
+	// push-mode: no more octets will arrive.
+	bool finish();
+	// push-mode: true if the parser has run out of input but more is expected.
+	bool starved();
 	// close parsing
 	void close();
 	// True if parser has reached end of stream
@@ -87,6 +127,20 @@ public:
 	// retrieve PC Data (free text nodes under an element).
 	bool readPCData(std::string &strData);
 	bool readPCData(std::wstring &strData);
+	// retrieve a CDATA section's content as-is; no entities are expanded.
+	// adjacent sections are concatenated.
+	bool readCData(std::string &strData);
+	bool readCData(std::wstring &strData);
+	// stream PC Data to a sink in bounded chunks, entities expanded.
+	// suits text too large to hold in memory or in the read-ahead buffer.
+	// returns false if there is no text.
+	bool readPCData(IOutputStream *pSink);
+	// stream a CDATA section's content to a sink in bounded chunks, as-is.
+	// returns false if there is no CDATA section.
+	bool readCData(IOutputStream *pSink);
+	// stream-decode base64 PC Data to a sink in bounded chunks.
+	// returns false if the text is not valid base64.
+	bool readBase64(IOutputStream *pSink);
 	// begin/end iterators for current element's attributes.
 	bool enumAttributes(std::list< std::pair<std::string, std::string> >::iterator &itBegin, 
 		std::list< std::pair<std::string, std::string> >::iterator &itEnd);
@@ -94,6 +148,8 @@ public:
 	bool getElementName(std::string &strElement);
 	// number of child elements skipped.
 	size_t getSkipped(bool bDocument) const;
+	// number of open elements.
+	size_t getDepth() const;
 };
 
 };
\ No newline at end of file
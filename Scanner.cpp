@@ -0,0 +1,171 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Scanner.h"
+#include <ctype.h>
+
+namespace XML
+{
+
+Scanner::Scanner() : _state(Text), _kind(None), _chLast(0), _iDashes(0)
+{
+}
+
+// forget any markup in progress.
+void Scanner::reset()
+{
+	_state = Text;
+	_kind = None;
+	_chLast = 0;
+	_iDashes = 0;
+}
+
+// true if between markup eg. in text content.
+bool Scanner::isText() const
+{
+	return _state == Text;
+}
+
+// true if inside a tag (start, end or empty) or its opening '<'.
+bool Scanner::isTag() const
+{
+	return _state == Open || _state == Tag || _state == Quote || _state == Apos;
+}
+
+// element name from tag text eg. "<name ...>" or "</name>".
+void Scanner::getName(const std::string &strTag, std::string &strName)
+{
+	size_t i = 1;
+	if (i < strTag.size() && strTag[i] == '/')
+		i++;
+	size_t iEnd = i;
+	while ( iEnd < strTag.size() && strTag[iEnd] != '/' && strTag[iEnd] != '>' && 
+		!isspace((unsigned char)strTag[iEnd]) )
+		iEnd++;
+	strName.assign(strTag, i, iEnd - i);
+}
+
+// markup is complete: return to text.
+Scanner::Markup Scanner::done(Markup kind)
+{
+	_state = Text;
+	_kind = None;
+	_chLast = 0;
+	return kind;
+}
+
+// scan an octet inside a tag.
+Scanner::Markup Scanner::scanTag(char ch)
+{
+	switch (ch)
+	{
+		case '"':
+			_state = Quote;
+			break;
+		case '\'':
+			_state = Apos;
+			break;
+		case '>':
+			return done( _kind == StartTag && _chLast == '/' ? EmptyTag : _kind );
+		default:
+			if ( !isspace((unsigned char)ch) )
+				_chLast = ch;
+			break;
+	}
+	return None;
+}
+
+// scan one octet; returns the kind of markup this octet completed, if any.
+Scanner::Markup Scanner::scan(char ch)
+{
+	switch (_state)
+	{
+		case Text:
+			if (ch == '<')
+				_state = Open;
+			break;
+		case Open:
+			if (ch == '!')
+				_state = Bang;
+			else if (ch == '?')
+			{
+				_state = InInstruction;
+				_kind = Instruction;
+			}
+			else if (ch == '/')
+			{
+				_state = Tag;
+				_kind = EndTag;
+			}
+			else
+			{
+				_state = Tag;
+				_kind = StartTag;
+				return scanTag(ch);
+			}
+			break;
+		case Bang:
+			if (ch == '-')
+			{
+				_state = BangDash;
+				break;
+			}
+			if (ch == '[')
+			{
+				// <![CDATA[ ... ]]>
+				_state = InCData;
+				_kind = CData;
+				_iDashes = 0;
+				break;
+			}
+			_state = InDeclaration;
+			_kind = Declaration;
+			if (ch == '>')
+				return done(Declaration);
+			break;
+		case BangDash:
+			if (ch == '-')
+			{
+				_state = InComment;
+				_kind = Comment;
+				_iDashes = 0;
+				break;
+			}
+			_state = InDeclaration;
+			_kind = Declaration;
+			if (ch == '>')
+				return done(Declaration);
+			break;
+		case Tag:
+			return scanTag(ch);
+		case Quote:
+			if (ch == '"')
+				_state = Tag;
+			break;
+		case Apos:
+			if (ch == '\'')
+				_state = Tag;
+			break;
+		case InComment:
+			if (ch == '>' && _iDashes >= 2)
+				return done(Comment);
+			_iDashes = ch == '-' ? _iDashes + 1 : 0;
+			break;
+		case InCData:
+			if (ch == '>' && _iDashes >= 2)
+				return done(CData);
+			_iDashes = ch == ']' ? _iDashes + 1 : 0;
+			break;
+		case InInstruction:
+			if (ch == '>' && _chLast == '?')
+				return done(Instruction);
+			_chLast = ch;
+			break;
+		case InDeclaration:
+			if (ch == '>')
+				return done(Declaration);
+			break;
+	}
+	return None;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,51 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include <stddef.h>
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Incremental markup scanner.
+// Classifies XML text one octet at a time so scanning can stop and resume at
+// any chunk boundary. It finds where markup (tags, comments, processing
+// instructions and declarations) begins and ends but does not otherwise parse it.
+class Scanner
+{
+public:
+	// kind of markup completed by an octet.
+	enum Markup { None, StartTag, EmptyTag, EndTag, Comment, Instruction, Declaration, CData };
+
+private:
+	enum State { Text, Open, Bang, BangDash, Tag, Quote, Apos, InComment, InInstruction, InDeclaration, InCData };
+
+	State _state;
+	// kind of markup in progress.
+	Markup _kind;
+	// most recent non-space octet inside markup.
+	char _chLast;
+	// consecutive dashes seen inside a comment, or brackets inside a CDATA section.
+	size_t _iDashes;
+
+	// markup is complete: return to text.
+	Markup done(Markup kind);
+	// scan an octet inside a tag.
+	Markup scanTag(char ch);
+
+public:
+	Scanner();
+	// forget any markup in progress.
+	void reset();
+	// scan one octet; returns the kind of markup this octet completed, if any.
+	Markup scan(char ch);
+	// true if between markup eg. in text content.
+	bool isText() const;
+	// true if inside a tag (start, end or empty) or its opening '<'.
+	bool isTag() const;
+	// element name from tag text eg. "<name ...>" or "</name>".
+	static void getName(const std::string &strTag, std::string &strName);
+};
+
+};
\ No newline at end of file
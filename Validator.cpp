@@ -0,0 +1,202 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Validator.h"
+#include <string.h>
+
+namespace XML
+{
+
+// word-at-a-time tests on eight octets.
+static const unsigned long long iOnes = 0x0101010101010101ULL;
+static const unsigned long long iHighs = 0x8080808080808080ULL;
+
+// true if any octet in iWord is zero.
+static inline bool hasZero(unsigned long long iWord)
+{
+	return ((iWord - iOnes) & ~iWord & iHighs) != 0;
+}
+
+// true if any octet in iWord is below n; octets must all be below 0x80.
+static inline bool hasLess(unsigned long long iWord, unsigned char n)
+{
+	return ((iWord - iOnes * n) & ~iWord & iHighs) != 0;
+}
+
+Validator::Validator() : _pStream(NULL), _iOffset(0), _iLine(1), _iPending(0), 
+	_chLow(0x80), _chHigh(0xBF), _iErrorOffset(0), _iErrorLine(0)
+{
+}
+
+// validate octets read from pStream.
+bool Validator::open(IInputStream *pStream)
+{
+	_pStream = pStream;
+	_scanner.reset();
+	_stack.clear();
+	_strTag.resize(0);
+	_iOffset = 0;
+	_iLine = 1;
+	_iPending = 0;
+	_chLow = 0x80;
+	_chHigh = 0xBF;
+	_strError.resize(0);
+	_iErrorOffset = 0;
+	_iErrorLine = 0;
+	return _pStream != NULL;
+}
+
+bool Validator::Read(unsigned char *pOctets, size_t iOctets, size_t &iRead)
+{
+	iRead = 0;
+	if ( _pStream == NULL || _strError.size() > 0 )
+		return false;
+	if ( !_pStream->Read(pOctets, iOctets, iRead) || iRead == 0 )
+	{
+		iRead = 0;
+		finish();
+		return false;
+	}
+	if ( !check(pOctets, iRead) )
+	{
+		iRead = 0;
+		return false;
+	}
+	return true;
+}
+
+void Validator::Close()
+{
+	if (_pStream != NULL)
+		_pStream->Close();
+	_pStream = NULL;
+}
+
+// true if an error was found; describes the first one.
+bool Validator::getError(std::string &strError, unsigned long long &iOffset, size_t &iLine) const
+{
+	strError = _strError;
+	iOffset = _iErrorOffset;
+	iLine = _iErrorLine;
+	return _strError.size() > 0;
+}
+
+// record an error at the current position.
+bool Validator::fail(const char *strError, const std::string &strDetail)
+{
+	if (_strError.size() == 0)
+	{
+		_strError = strError;
+		_strError += strDetail;
+		_iErrorOffset = _iOffset;
+		_iErrorLine = _iLine;
+	}
+	return false;
+}
+
+// check that the document ended cleanly.
+bool Validator::finish()
+{
+	if (_iPending > 0)
+		return fail("truncated UTF-8 sequence", "");
+	if ( !_scanner.isText() )
+		return fail("unterminated markup", "");
+	if (_stack.size() > 0)
+		return fail("unclosed element ", _stack.back());
+	return true;
+}
+
+// check a chunk; false on the first error.
+bool Validator::check(const unsigned char *pOctets, size_t iOctets)
+{
+	std::string strName;
+	size_t i = 0;
+	while (i < iOctets)
+	{
+		// fast path: skip plain text eight octets at a time, stopping
+		// at anything that needs a closer look (non-ASCII, control
+		// characters including line ends, and '<').
+		if ( _iPending == 0 && _scanner.isText() )
+		{
+			while (iOctets - i >= 8)
+			{
+				unsigned long long iWord = 0;
+				memcpy(&iWord, pOctets + i, 8);
+				if ( (iWord & iHighs) != 0 || hasLess(iWord, 0x20) || hasZero(iWord ^ (iOnes * '<')) )
+					break;
+				i += 8;
+				_iOffset += 8;
+			}
+			if (i == iOctets)
+				break;
+		}
+
+		unsigned char ch = pOctets[i];
+		if (_iPending > 0)
+		{
+			if (ch < _chLow || ch > _chHigh)
+				return fail("invalid UTF-8 sequence", "");
+			_chLow = 0x80;
+			_chHigh = 0xBF;
+			_iPending--;
+		}
+		else if (ch >= 0x80)
+		{
+			// lead octet; the first continuation range excludes overlong
+			// forms, surrogates and code points beyond U+10FFFF.
+			if (ch >= 0xC2 && ch <= 0xDF)
+				_iPending = 1;
+			else if (ch >= 0xE0 && ch <= 0xEF)
+			{
+				_iPending = 2;
+				if (ch == 0xE0)
+					_chLow = 0xA0;
+				else if (ch == 0xED)
+					_chHigh = 0x9F;
+			}
+			else if (ch >= 0xF0 && ch <= 0xF4)
+			{
+				_iPending = 3;
+				if (ch == 0xF0)
+					_chLow = 0x90;
+				else if (ch == 0xF4)
+					_chHigh = 0x8F;
+			}
+			else
+				return fail("invalid UTF-8 sequence", "");
+		}
+		else if (ch < 0x20 && ch != '\t' && ch != '\n' && ch != '\r')
+			return fail("illegal character", "");
+
+		Scanner::Markup markup = _scanner.scan((char)ch);
+		if ( _scanner.isTag() || markup == Scanner::StartTag || 
+			markup == Scanner::EmptyTag || markup == Scanner::EndTag )
+			_strTag += (char)ch;
+		switch (markup)
+		{
+			case Scanner::StartTag:
+				Scanner::getName(_strTag, strName);
+				_stack.push_back(strName);
+				break;
+			case Scanner::EndTag:
+				Scanner::getName(_strTag, strName);
+				if (_stack.size() == 0)
+					return fail("unexpected end tag ", strName);
+				if (_stack.back() != strName)
+					return fail("mismatched end tag ", strName);
+				_stack.pop_back();
+				break;
+			default:
+				break;
+		}
+		if (markup != Scanner::None)
+			_strTag.resize(0);
+
+		if (ch == '\n')
+			_iLine++;
+		_iOffset++;
+		i++;
+	}
+	return true;
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,58 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+#include "Scanner.h"
+#include <vector>
+#include <string>
+
+#pragma once
+
+namespace XML
+{
+
+// Validating input stream.
+// Sits between a source stream and the parser, checking each chunk as the
+// parser reads it: UTF-8 encoding, illegal control characters, unterminated
+// markup and balanced element tags. The first error stops the stream, so the
+// parser sees end of stream, and is reported with its octet offset and line.
+// Because of the parser's read-ahead, an error may be reported a little
+// before the parser reaches it.
+class Validator : public IInputStream
+{
+	IInputStream *_pStream;
+	Scanner _scanner;
+	// names of open elements.
+	std::vector<std::string> _stack;
+	// text of the tag being scanned.
+	std::string _strTag;
+	// offset and line of the next octet.
+	unsigned long long _iOffset;
+	size_t _iLine;
+	// continuation octets still expected for the current UTF-8 sequence
+	// and the range allowed for the next one.
+	size_t _iPending;
+	unsigned char _chLow;
+	unsigned char _chHigh;
+	// first error found, if any.
+	std::string _strError;
+	unsigned long long _iErrorOffset;
+	size_t _iErrorLine;
+
+	// check a chunk; false on the first error.
+	bool check(const unsigned char *pOctets, size_t iOctets);
+	// check that the document ended cleanly.
+	bool finish();
+	// record an error at the current position.
+	bool fail(const char *strError, const std::string &strDetail);
+
+public:
+	Validator();
+	// validate octets read from pStream.
+	bool open(IInputStream *pStream);
+	virtual bool Read(unsigned char *pOctets, size_t iOctets, size_t &iRead);
+	virtual void Close();
+	// true if an error was found; describes the first one.
+	bool getError(std::string &strError, unsigned long long &iOffset, size_t &iLine) const;
+};
+
+};
\ No newline at end of file
@@ -0,0 +1,126 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "Vector.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#include <share.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#endif
+
+namespace XML
+{
+
+FileVectorStream::FileVectorStream() : _iFile(-1)
+{
+}
+
+FileVectorStream::~FileVectorStream()
+{
+	Close();
+}
+
+// create or truncate the file.
+bool FileVectorStream::Open(const char *strPath)
+{
+	Close();
+#ifdef _WIN32
+	_sopen_s(&_iFile, strPath, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _SH_DENYWR, _S_IREAD | _S_IWRITE);
+#else
+	_iFile = open(strPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+	return _iFile != -1;
+}
+
+bool FileVectorStream::Write(unsigned char *pOctets, size_t iOctets, size_t &iWrote)
+{
+	Segment segment = { pOctets, iOctets };
+	return WriteVector(&segment, 1, iWrote);
+}
+
+bool FileVectorStream::WriteVector(const Segment *pSegments, size_t iSegments, size_t &iWrote)
+{
+	iWrote = 0;
+	if (_iFile == -1)
+		return false;
+#ifdef _WIN32
+	// no writev equivalent for ordinary (buffered) file handles.
+	for (size_t i = 0; i < iSegments; i++)
+	{
+		const unsigned char *pOctets = pSegments[i].pOctets;
+		size_t iOctets = pSegments[i].iOctets;
+		while (iOctets > 0)
+		{
+			unsigned int iChunk = iOctets > 0x40000000 ? 0x40000000 : (unsigned int)iOctets;
+			int iDone = _write(_iFile, pOctets, iChunk);
+			if (iDone <= 0)
+				return false;
+			pOctets += iDone;
+			iOctets -= iDone;
+			iWrote += iDone;
+		}
+	}
+#else
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+	struct iovec vec[64];
+	size_t iNext = 0;
+	// offset into the first segment left over from a partial write.
+	size_t iPartial = 0;
+	while (iNext < iSegments)
+	{
+		int iCount = 0;
+		while (iNext + iCount < iSegments && iCount < 64 && iCount < IOV_MAX)
+		{
+			const Segment &segment = pSegments[iNext + iCount];
+			size_t iSkip = iCount == 0 ? iPartial : 0;
+			vec[iCount].iov_base = (void *)(segment.pOctets + iSkip);
+			vec[iCount].iov_len = segment.iOctets - iSkip;
+			iCount++;
+		}
+		ssize_t iDone = writev(_iFile, vec, iCount);
+		if (iDone < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		iWrote += iDone;
+		// advance past fully written segments.
+		size_t iLeft = (size_t)iDone;
+		for (int i = 0; i < iCount; i++)
+		{
+			if (iLeft < vec[i].iov_len)
+			{
+				iPartial += iLeft;
+				break;
+			}
+			iLeft -= vec[i].iov_len;
+			iNext++;
+			iPartial = 0;
+		}
+	}
+#endif
+	return true;
+}
+
+void FileVectorStream::Close()
+{
+	if (_iFile != -1)
+	{
+#ifdef _WIN32
+		_close(_iFile);
+#else
+		close(_iFile);
+#endif
+		_iFile = -1;
+	}
+}
+
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+// Copyright  2008-2011 Rick Parrish
+
+#include "../Stream/Stream.h"
+
+#pragma once
+
+namespace XML
+{
+
+// one scatter / gather segment; the counterpart of struct iovec.
+struct Segment
+{
+	const unsigned char *pOctets;
+	size_t iOctets;
+};
+
+// output stream that can write several segments in a single call.
+// Writer recognizes these streams and passes long values by reference
+// instead of copying them.
+class IVectorStream : public IOutputStream
+{
+public:
+	virtual bool WriteVector(const Segment *pSegments, size_t iSegments, size_t &iWrote) = 0;
+};
+
+// file output stream; vectored writes map onto writev.
+class FileVectorStream : public IVectorStream
+{
+	int _iFile;
+
+public:
+	FileVectorStream();
+	~FileVectorStream();
+	// create or truncate the file.
+	bool Open(const char *strPath);
+	virtual bool Write(unsigned char *pOctets, size_t iOctets, size_t &iWrote);
+	virtual bool WriteVector(const Segment *pSegments, size_t iSegments, size_t &iWrote);
+	virtual void Close();
+};
+
+};
\ No newline at end of file
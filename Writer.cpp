@@ -1,6 +1,8 @@
 // Copyright  2008-2011 Rick Parrish
 
 #include "Writer.h"
+#include "Base64.h"
+#include <string.h>
 
 namespace XML
 {
@@ -50,8 +52,14 @@ static void insertEntities(const TCHAR *strText, std::string &strEntity)
 	}
 }
 
+// text runs at least this long are passed by reference to vectored streams.
+static const size_t iReference = 256;
+// staged octets or queued spans beyond these limits force a flush.
+static const size_t iStageLimit = 65536;
+static const size_t iSpanLimit = 512;
+
 Writer::Writer() :
-	_pStream(NULL)
+	_pStream(NULL), _pVector(NULL)
 {
 }
 
@@ -68,6 +76,15 @@ void Writer::adopt()
 
 bool Writer::writePCData(const TCHAR *strPCData)
 {
+#ifndef UNICODE
+	if (_pVector != NULL)
+	{
+		adopt();
+		// runs passed by reference must be written before the caller's text goes away.
+		return !writeEscaped(strPCData) || flush();
+	}
+#endif
+	// plain streams: escape into one buffer for a single write.
 	std::string strEntity;
 	insertEntities(strPCData, strEntity);
 	adopt();
@@ -75,6 +92,100 @@ bool Writer::writePCData(const TCHAR *strPCData)
 	return true;
 }
 
+// write a CDATA section; content is copied in bulk without entity insertion.
+// any "]]>" in the content is split across two sections.
+bool Writer::writeCData(const char *pData, size_t iLen)
+{
+	bool bReference = false;
+	const char *pEnd = pData + iLen;
+	adopt();
+	writeString("<![CDATA[");
+	while (true)
+	{
+		// find the next "]]>" terminator, if any.
+		const char *pSplit = pData;
+		while ( (pSplit = (const char *)memchr(pSplit, ']', pEnd - pSplit)) != NULL )
+		{
+			if (pEnd - pSplit >= 3 && pSplit[1] == ']' && pSplit[2] == '>')
+				break;
+			pSplit++;
+		}
+		// through "]]" of the terminator; the '>' opens the next section.
+		const char *pRun = pSplit != NULL ? pSplit + 2 : pEnd;
+		size_t iRun = pRun - pData;
+		if (iRun >= iReference)
+		{
+			writeReference(pData, iRun);
+			bReference = true;
+		}
+		else if (iRun > 0)
+			writeString(pData, iRun);
+		if (pSplit == NULL)
+			break;
+		writeString("]]><![CDATA[");
+		pData = pRun;
+	}
+	writeString("]]>");
+	// runs passed by reference must be written before the caller's buffer goes away.
+	return !bReference || flush();
+}
+
+// write content as-is; the caller is responsible for any entities.
+bool Writer::writeRaw(const char *pData, size_t iLen)
+{
+	adopt();
+	writeReference(pData, iLen);
+	return true;
+}
+
+// write text with entities inserted; long clean runs are passed by reference.
+// returns true if any run was passed by reference.
+bool Writer::writeEscaped(const char *strText)
+{
+	bool bReference = false;
+	const char *strRun = strText;
+	while (true)
+	{
+		const char *strEntity = NULL;
+		switch (*strText)
+		{
+			case '\'':
+				strEntity = "&apos;";
+				break;
+			case '&':
+				strEntity = "&amp;";
+				break;
+			case '<':
+				strEntity = "&lt;";
+				break;
+			case '>':
+				strEntity = "&gt;";
+				break;
+			case '"':
+				strEntity = "&quot;";
+				break;
+			case 0:
+				break;
+			default:
+				strText++;
+				continue;
+		}
+		size_t iLen = strText - strRun;
+		if (iLen >= iReference)
+		{
+			writeReference(strRun, iLen);
+			bReference = true;
+		}
+		else if (iLen > 0)
+			writeString(strRun, iLen);
+		if (strEntity == NULL)
+			break;
+		writeString(strEntity);
+		strRun = ++strText;
+	}
+	return bReference;
+}
+
 bool Writer::writeStartElement(const char *strElement)
 {
 	entry e;
@@ -217,23 +328,141 @@ bool Writer::open(IOutputStream *pStream)
 {
 	const char strPreamble[] = "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n";
 	if (_pStream != NULL)
+	{
+		flush();
 		_pStream->Close();
+	}
 	_pStream = pStream;
+	_pVector = NULL;
 	size_t iWrote = 0;
 	return _pStream->Write( (unsigned char *)strPreamble, _countof(strPreamble) - 1, iWrote );
 }
 
+// open a stream accepting vectored writes; long values are not copied.
+bool Writer::open(IVectorStream *pStream)
+{
+	bool bOK = open( (IOutputStream *)pStream );
+	_pVector = pStream;
+	return bOK;
+}
+
+// open without writing the XML preamble; used for writing fragments.
+bool Writer::openFragment(IOutputStream *pStream)
+{
+	if (_pStream != NULL)
+	{
+		flush();
+		_pStream->Close();
+	}
+	_pStream = pStream;
+	_pVector = NULL;
+	return _pStream != NULL;
+}
+
+// base64 encode PC Data read from a source, a chunk at a time.
+bool Writer::writeBase64(IInputStream *pSource)
+{
+	Base64 encoder;
+	std::vector<unsigned char> octets(12288);
+	std::string strText;
+	strText.reserve(octets.size() / 3 * 4 + 4);
+	size_t iRead = 0;
+	adopt();
+	while ( pSource->Read(&octets[0], octets.size(), iRead) && iRead > 0 )
+	{
+		strText.resize(0);
+		encoder.encode(&octets[0], iRead, strText);
+		writeString(strText.data(), strText.size());
+	}
+	strText.resize(0);
+	encoder.finish(strText);
+	writeString(strText.data(), strText.size());
+	return true;
+}
+
+// splice a fragment written by another Writer into this document.
+// the fragment's content is written as-is; vectored streams take it by reference.
+bool Writer::writeFragment(const Fragment &fragment)
+{
+	adopt();
+	if (_pVector == NULL)
+	{
+		size_t iWrote = 0;
+		return _pStream->Write( (unsigned char *)fragment.data(), fragment.size(), iWrote );
+	}
+	writeReference(fragment.data(), fragment.size());
+	return flush();
+}
+
+// hand any queued output to the stream.
+bool Writer::flush()
+{
+	bool bOK = true;
+	if (_spans.size() > 0)
+	{
+		std::vector<Segment> segments(_spans.size());
+		for (size_t i = 0; i < _spans.size(); i++)
+		{
+			const span &s = _spans[i];
+			segments[i].pOctets = (const unsigned char *)(s.Text != NULL ? s.Text : _strStage.data() + s.Offset);
+			segments[i].iOctets = s.Length;
+		}
+		size_t iWrote = 0;
+		bOK = _pVector->WriteVector(&segments[0], segments.size(), iWrote);
+		_spans.resize(0);
+		_strStage.resize(0);
+	}
+	return bOK;
+}
+
 void Writer::close()
 {
+	flush();
 	_pStream->Close();
 	_pStream = NULL;
+	_pVector = NULL;
+}
+
+void Writer::writeString(const char *strText, size_t iLen)
+{
+	if (_pVector != NULL)
+	{
+		// merge with the previous staged span where possible.
+		if (_spans.size() > 0 && _spans.back().Text == NULL)
+			_spans.back().Length += iLen;
+		else
+		{
+			span s = { NULL, _strStage.size(), iLen };
+			_spans.push_back(s);
+		}
+		_strStage.append(strText, iLen);
+		if (_strStage.size() >= iStageLimit || _spans.size() >= iSpanLimit)
+			flush();
+	}
+	else
+	{
+		size_t iWrote = 0;
+		_pStream->Write((unsigned char *)strText, iLen, iWrote);
+	}
+}
+
+// pass a buffer by reference when the stream allows; valid until flush.
+void Writer::writeReference(const char *strText, size_t iLen)
+{
+	if (_pVector != NULL)
+	{
+		span s = { strText, 0, iLen };
+		_spans.push_back(s);
+		if (_spans.size() >= iSpanLimit)
+			flush();
+	}
+	else
+		writeString(strText, iLen);
 }
 
 void Writer::writeString(const char *strText)
 {
-	size_t iLen = strlen(strText);
-	size_t iWrote = 0;
-	_pStream->Write((unsigned char *)strText, iLen, iWrote);
+	writeString(strText, strlen(strText));
 }
 
 void Writer::writeString(const wchar_t *strText)
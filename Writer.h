@@ -1,6 +1,8 @@
 // Copyright  2008-2011 Rick Parrish
 
 #include "../Stream/Stream.h"
+#include "Fragment.h"
+#include "Vector.h"
 #include <tchar.h>
 #include <vector>
 #include <string>
@@ -22,10 +24,31 @@ class Writer
 		entry(const entry &copy) : Children(copy.Children), Element(copy.Element), Skipped(copy.Skipped) { };
 	};
 
+	// output queued for a vectored write: staged copy or caller's buffer.
+	struct span
+	{
+		// caller's buffer, or NULL if staged.
+		const char *Text;
+		// offset into staging buffer.
+		size_t Offset;
+		size_t Length;
+	};
+
 	IOutputStream *_pStream;
+	// same as _pStream when it accepts vectored writes.
+	IVectorStream *_pVector;
 	std::vector<entry> _stack;
+	// short strings are copied here pending a vectored write.
+	std::string _strStage;
+	std::vector<span> _spans;
 
 	void adopt();
+	void writeString(const char *strText, size_t iLen);
+	// pass a buffer by reference when the stream allows; valid until flush.
+	void writeReference(const char *strText, size_t iLen);
+	// write text with entities inserted; long clean runs are passed by reference.
+	// returns true if any run was passed by reference.
+	bool writeEscaped(const char *strText);
 	void writeString(std::string &strText);
 	void writeString(std::wstring &strText);
 	void writeString(const wchar_t *strText);
@@ -50,7 +73,24 @@ public:
 	bool writeEndElement();
 	bool writeStringElement(const char *strElement, const TCHAR *strValue);
 	bool writePCData(const TCHAR *strPCData);
+	// write a CDATA section; content is copied in bulk without entity insertion.
+	// any "]]>" in the content is split across two sections.
+	bool writeCData(const char *pData, size_t iLen);
+	// write content as-is; the caller is responsible for any entities.
+	// On a vectored stream the buffer is referenced, not copied, and must
+	// remain valid until flush or close.
+	bool writeRaw(const char *pData, size_t iLen);
+	// base64 encode PC Data read from a source, a chunk at a time.
+	bool writeBase64(IInputStream *pSource);
+	// splice a fragment written by another Writer into this document.
+	bool writeFragment(const Fragment &fragment);
 	bool open(IOutputStream *);
+	// open a stream accepting vectored writes; long values are not copied.
+	bool open(IVectorStream *);
+	// hand any queued output to the stream.
+	bool flush();
+	// open without writing the XML preamble; used for writing fragments.
+	bool openFragment(IOutputStream *);
 	void close();
 	Writer();
 };